@@ -579,7 +579,7 @@ def runLowOrderPrimal4PC():
         DASolver.updateDAOption()
         DASolver()
         DASolver.dRdWTPC = PETSc.Mat().create(PETSc.COMM_WORLD)
-        DASolver.solver.calcdRdWT(DASolver.xvVec, DASolver.wVec, 1, DASolver.dRdWTPC)
+        DASolver.calcdRdWTPC(DASolver.dRdWTPC)
         DASolver.setOption("runLowOrderPrimal4PC", {"isPC": False})
         DASolver.updateDAOption()
 
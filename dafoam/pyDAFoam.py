@@ -14,10 +14,12 @@
 __version__ = "3.1.0"
 
 import subprocess
+import time
 import os
 import sys
 import copy
 import shutil
+import json
 import numpy as np
 from mpi4py import MPI
 from collections import OrderedDict
@@ -391,6 +393,12 @@ class DAOPTION(object):
         ## },
         self.fvSource = {}
 
+        ## Whether to use the cell bins to find the cells near the smooth actuator sources (actuatorDisk
+        ## with cylinderAnnulusSmooth, actuatorLine, and actuatorPoint) instead of looping over all the cells.
+        ## The cells far from the sources are skipped because their source terms are below the machine
+        ## precision, so the results are the same. Setting it to False is mainly for testing
+        self.fvSourceCellBins = True
+
         ## The adjoint equation solution method. Options are: Krylov or fixedPoint
         self.adjEqnSolMethod = "Krylov"
 
@@ -452,6 +460,15 @@ class DAOPTION(object):
             "ACTL": 1.0e-2,
         }
 
+        ## The method to compute the dRdW partial derivative matrices, e.g., the preconditioner
+        ## matrix dRdWTPC. FD: coloring accelerated finite-difference, one residual evaluation per
+        ## color. batchedAD: record the residual computation in the AD tape once and evaluate the tape
+        ## in forward vector mode for 8 colors at a time (useAD-mode=reverse only). The PC mat is then
+        ## computed by self.solverAD. Use benchmarkdRdWTPC to compare the speed of these two methods.
+        ## NOTE: batchedAD does not support regressionModel or tensorflow (e.g., kOmegaSSTFIML)
+        ## because their AD functions are reverse mode only
+        self.adjPartDerivMethod = "FD"
+
         ## Which options to use to improve the adjoint equation convergence of transonic conditions
         ## This is used only for transonic solvers such as DARhoSimpleCFoam
         self.transonicPCOption = -1
@@ -459,6 +476,27 @@ class DAOPTION(object):
         ## Options for unsteady adjoint. mode can be hybrid or timeAccurate
         ## Here nTimeInstances is the number of time instances and periodicity is the
         ## periodicity of flow oscillation (hybrid adjoint only)
+        ## checkpointMethod: None, binomial, or multiLevel (timeAccurate adjoint only). If None, the
+        ## primal writes the states to the disk for every time step and the adjoint reads them back.
+        ## If binomial, we keep nCheckpointsRAM snapshots in memory and recompute the missing time
+        ## steps during the adjoint (revolve-type schedule). The memory cost is independent of the
+        ## number of time steps and the recompute cost grows logarithmically with it.
+        ## multiLevel is similar to binomial, except that we additionally keep nCheckpointsDisk
+        ## snapshots on the local disk (the processor*/checkpoints folder). The disk snapshots are only
+        ## used once the RAM ones are full and nCheckpointsRAM can be 0 for a disk-only schedule.
+        ## With checkpointing, the primal does not write the states to the time folders except for
+        ## the last time step.
+        ## snapshotFormat: OpenFOAM or binary. If binary, the primal saves the states for each time
+        ## step to one binary file per processor (the processor*/snapshots folder) in a background
+        ## thread, and the adjoint reads them with mmap and prefetches the previous time step.
+        ## The last time step is still written in the OpenFOAM format for post-processing.
+        ## snapshotPrecision: double or single (binary only). single halves the file size but the
+        ## states used in the adjoint are rounded to float32, i.e., the adjoint is linearized at states
+        ## that differ from the primal ones by a relative error of about 1e-7. The totals are then only
+        ## accurate to about 1e-4 to 1e-3 (relative), depending on the case and the number of time steps,
+        ## so use double if the totals are verified against finite differences or tight tolerances.
+        ## snapshotCompression: None or shuffleRLE (binary only). shuffleRLE is a lossless
+        ## compression that works best for single precision and fields with uniform regions.
         self.unsteadyAdjoint = {
             "mode": "None",
             "nTimeInstances": -1,
@@ -469,6 +507,12 @@ class DAOPTION(object):
             "PCMatPrecomputeInterval": 100,
             "PCMatUpdateInterval": 1,
             "reduceIO": True,
+            "checkpointMethod": "None",
+            "nCheckpointsRAM": 100,
+            "nCheckpointsDisk": 0,
+            "snapshotFormat": "OpenFOAM",
+            "snapshotPrecision": "double",
+            "snapshotCompression": "None",
         }
 
         ## At which iteration should we start the averaging of objective functions.
@@ -556,6 +600,13 @@ class DAOPTION(object):
         ## The print interval of unsteady primal solvers, e.g., for DAPisoFoam
         self.printIntervalUnsteady = 500
 
+        ## Whether to profile the hot paths in the C++ layer, i.e., the wall time and call counts of the
+        ## residual, boundary condition, partial derivative, AD tape, and Krylov phases, the peak
+        ## memory, and the AD tape size for each processor. Call getProfile to get the statistics as a
+        ## dict, or call writeProfile to save them to fileName (JSON) along with a summary over all
+        ## processors. The profiler costs a flag check per timer when active is False
+        self.profiler = {"active": False, "fileName": "DAFoamProfile.json"}
+
         ## Users can adjust primalMinResTolDiff to tweak how much difference between primalMinResTol
         ## and the actual primal convergence is consider to be fail=True for the primal solution.
         self.primalMinResTolDiff = 1.0e2
@@ -564,9 +615,33 @@ class DAOPTION(object):
         ## debugging the accuracy of partial computation, always set it to True
         self.adjUseColoring = True
 
+        ## The graph coloring method for the partial derivative Jacobians. parallelD2: the
+        ## original DAFoam parallel distance-2 heuristic. greedy: PETSc's speculative greedy
+        ## distance-2 coloring. jp: PETSc's Jones-Plassmann distance-2 coloring. greedy and jp are
+        ## typically faster and need fewer colors for large meshes; they are used for dRdW only
+        ## and dFdW always uses parallelD2. The coloring files are saved with a hash of the
+        ## connectivity sparsity and partition, and stale files are recomputed automatically
+        self.adjColoringMethod = "parallelD2"
+
+        ## The vertex ordering for adjColoringMethod = greedy or jp. Options are: largestFirst,
+        ## smallestLast, lexical, or random. smallestLast usually gives the fewest colors
+        self.adjColoringOrdering = "smallestLast"
+
         ## The Petsc options for solving the adjoint linear equation. These options should work for
         ## most of the case. If the adjoint does not converge, try to increase pcFillLevel to 2, or
         ## try "jacMatReOrdering": "nd"
+        ## recycleMode: reuse the information from previous adjoint solutions (previous optimization
+        ## iterations or time steps) for each objective function to reduce the number of GMRES iterations.
+        ## None: no recycling. projection: warm start from the minimal-residual combination of the
+        ## last recycleDim adjoint solutions (useAD-mode=reverse only). gcrodr: use the GCRO-DR solver from
+        ## HPDDM, which keeps a deflation subspace of dimension recycleDim (requires PETSc with HPDDM). The
+        ## subspace is reset when dRdWTPC is recomputed, see adjPCLag. The number of iterations is printed
+        ## against the previous solution of the same objective function. NOTE: the mphys wrapper solves all
+        ## objective functions with one KSP, so gcrodr shares the deflation subspace among them and
+        ## projection is not used
+        ## multiRHS: solve the adjoint equations for all objective functions together (useAD-mode=reverse
+        ## only). The dRdWT tape is recorded once and evaluated in vector mode for multiple vectors.
+        ## If PETSc is built with HPDDM, a block GMRES is used and the PC is applied to all vectors at once
         self.adjEqnOption = {
             "globalPCIters": 0,
             "asmOverlap": 1,
@@ -581,6 +656,9 @@ class DAOPTION(object):
             "useNonZeroInitGuess": False,
             "useMGSO": False,
             "printInfo": 1,
+            "multiRHS": False,
+            "recycleMode": "None",
+            "recycleDim": 10,
             "fpMaxIters": 1000,
             "fpRelTol": 1e-6,
             "fpMinResTolDiff": 1.0e2,
@@ -888,6 +966,11 @@ class PYDAFOAM(object):
         # initialize the dRdWTPC dict for unsteady adjoint
         self.dRdWTPCUnsteady = None
 
+        # the recycle spaces (previous adjoint solutions) for adjEqnOption-recycleMode=projection
+        # and the KSP objects kept across adjoint solutions for recycleMode=gcrodr, one for each objFunc
+        self.adjRecycleVecs = {}
+        self.adjRecycleKSPs = {}
+
         # initialize the user defined internal dvs dict
         self.internalDV = {}
 
@@ -1086,6 +1169,55 @@ class PYDAFOAM(object):
             if not self.getOption("useAD")["mode"] in ["forward", "reverse"]:
                 raise Error("timeAccurate only supports useAD->mode=forward|reverse")
 
+        # check the adjoint recycling options
+        recycleMode = self.getOption("adjEqnOption")["recycleMode"]
+        if recycleMode not in ["None", "projection", "gcrodr"]:
+            raise Error("adjEqnOption-recycleMode: %s not supported. Options are: None, projection, or gcrodr" % recycleMode)
+        if recycleMode == "projection" and self.getOption("useAD")["mode"] != "reverse":
+            raise Error("adjEqnOption-recycleMode=projection only supports useAD->mode=reverse")
+        if self.getOption("adjEqnOption")["multiRHS"] and self.getOption("useAD")["mode"] != "reverse":
+            raise Error("adjEqnOption-multiRHS=True only supports useAD->mode=reverse")
+
+        # check the partial derivative options
+        if self.getOption("adjPartDerivMethod") not in ["FD", "batchedAD"]:
+            raise Error("adjPartDerivMethod: %s not supported. Options are: FD or batchedAD" % self.getOption("adjPartDerivMethod"))
+        if self.getOption("adjPartDerivMethod") == "batchedAD" and self.getOption("useAD")["mode"] != "reverse":
+            raise Error("adjPartDerivMethod=batchedAD only supports useAD->mode=reverse")
+        if self.getOption("adjPartDerivMethod") == "batchedAD":
+            self._checkBatchedADModels()
+
+        # check the coloring options
+        if self.getOption("adjColoringMethod") not in ["parallelD2", "greedy", "jp"]:
+            raise Error("adjColoringMethod: %s not supported. Options are: parallelD2, greedy, or jp" % self.getOption("adjColoringMethod"))
+        if self.getOption("adjColoringOrdering") not in ["largestFirst", "smallestLast", "lexical", "random"]:
+            raise Error("adjColoringOrdering: %s not supported. Options are: largestFirst, smallestLast, lexical, or random" % self.getOption("adjColoringOrdering"))
+
+        # check the checkpointing options
+        checkpointMethod = self.getOption("unsteadyAdjoint")["checkpointMethod"]
+        if checkpointMethod != "None":
+            if self.getOption("unsteadyAdjoint")["mode"] != "timeAccurate":
+                raise Error("checkpointMethod is only supported for unsteadyAdjoint->mode=timeAccurate")
+            if checkpointMethod not in ["binomial", "multiLevel"]:
+                raise Error("checkpointMethod: %s not supported. Options are: None, binomial, or multiLevel" % checkpointMethod)
+            # only DAPimpleFoam implements solvePrimalTimeStep and initCheckpointing
+            if self.getOption("solverName") not in ["DAPimpleFoam"]:
+                raise Error("checkpointMethod=%s only supports solverName=DAPimpleFoam" % checkpointMethod)
+            # the same check as in DACheckpointing, nCheckpointsDisk is only used for multiLevel
+            nCheckpointsRAM = self.getOption("unsteadyAdjoint")["nCheckpointsRAM"]
+            nCheckpointsDisk = self.getOption("unsteadyAdjoint")["nCheckpointsDisk"]
+            if checkpointMethod != "multiLevel":
+                nCheckpointsDisk = 0
+            if nCheckpointsRAM < 0 or nCheckpointsDisk < 0 or nCheckpointsRAM + nCheckpointsDisk < 1:
+                raise Error("nCheckpointsRAM + nCheckpointsDisk should be at least 1 for checkpointMethod=%s" % checkpointMethod)
+
+        # check the snapshot options
+        if self.getOption("unsteadyAdjoint")["snapshotFormat"] not in ["OpenFOAM", "binary"]:
+            raise Error("snapshotFormat: %s not supported. Options are: OpenFOAM or binary" % self.getOption("unsteadyAdjoint")["snapshotFormat"])
+        if self.getOption("unsteadyAdjoint")["snapshotPrecision"] not in ["double", "single"]:
+            raise Error("snapshotPrecision: %s not supported. Options are: double or single" % self.getOption("unsteadyAdjoint")["snapshotPrecision"])
+        if self.getOption("unsteadyAdjoint")["snapshotCompression"] not in ["None", "shuffleRLE"]:
+            raise Error("snapshotCompression: %s not supported. Options are: None or shuffleRLE" % self.getOption("unsteadyAdjoint")["snapshotCompression"])
+
         if "NONE" not in self.getOption("writeSensMap"):
             if not self.getOption("useAD")["mode"] in ["reverse"]:
                 raise Error("writeSensMap is only compatible with useAD->mode=reverse")
@@ -1353,6 +1485,80 @@ class PYDAFOAM(object):
 
         return self.solver.getTimeInstanceObjFunc(instanceI, objFuncName.encode())
 
+    def getProfile(self):
+        """
+        Return the profiler statistics of this processor as a dict. The statistics of
+        self.solver and self.solverAD are reported separately because they are different
+        libraries. See the profiler option
+        """
+
+        profile = {"solver": json.loads(self.solver.getProfileJSON())}
+        if self.getOption("useAD")["mode"] in ["forward", "reverse"]:
+            profile["solverAD"] = json.loads(self.solverAD.getProfileJSON())
+
+        return profile
+
+    def resetProfile(self):
+        """
+        Clear the profiler statistics
+        """
+
+        self.solver.resetProfile()
+        if self.getOption("useAD")["mode"] in ["forward", "reverse"]:
+            self.solverAD.resetProfile()
+
+    def writeProfile(self, fileName=None):
+        """
+        Gather the profiler statistics from all processors and write them to fileName
+        (JSON). In addition to the statistics of each processor, we write a summary with
+        the min, mean, and max wall time of each phase over all processors. The
+        difference between the max and mean wall time is an estimate of the time spent
+        waiting in MPI communication due to load imbalance
+        """
+
+        if fileName is None:
+            fileName = self.getOption("profiler")["fileName"]
+
+        allProfiles = self.comm.gather(self.getProfile(), root=0)
+
+        if self.comm.rank == 0:
+            summary = {}
+            for solverName in allProfiles[0].keys():
+                phaseSummary = {}
+                phaseNames = set()
+                for profile in allProfiles:
+                    phaseNames.update(profile[solverName]["phases"].keys())
+                for phaseName in sorted(phaseNames):
+                    wallTimes = []
+                    nCalls = 0
+                    for profile in allProfiles:
+                        phase = profile[solverName]["phases"].get(phaseName, {"wallTime": 0.0, "nCalls": 0})
+                        wallTimes.append(phase["wallTime"])
+                        nCalls = max(nCalls, phase["nCalls"])
+                    phaseSummary[phaseName] = {
+                        "wallTimeMin": min(wallTimes),
+                        "wallTimeMean": sum(wallTimes) / len(wallTimes),
+                        "wallTimeMax": max(wallTimes),
+                        "imbalanceWait": max(wallTimes) - sum(wallTimes) / len(wallTimes),
+                        "nCallsMax": nCalls,
+                    }
+                summary[solverName] = {
+                    "peakMemoryMBMax": max([p[solverName]["peakMemoryMB"] for p in allProfiles]),
+                    "tapeUsedMemoryMBMax": max([p[solverName]["tape"]["usedMemoryMB"] for p in allProfiles]),
+                    "countersMax": {
+                        c: max([p[solverName]["counters"].get(c, 0) for p in allProfiles])
+                        for c in allProfiles[0][solverName]["counters"].keys()
+                    },
+                    "phases": phaseSummary,
+                }
+
+            with open(fileName, "w") as f:
+                json.dump({"nProcs": self.comm.size, "summary": summary, "procs": allProfiles}, f, indent=4)
+
+            Info("Profiler statistics written to %s" % fileName)
+
+        self.comm.Barrier()
+
     def getForwardADDerivVal(self, objFuncName):
         """
         Return the derivative value computed by forward mode AD primal solution
@@ -1953,6 +2159,32 @@ class PYDAFOAM(object):
         # is update to date for unsteady adjoint
         self.solver.ofField2StateVec(self.wVec)
 
+    def restoreCheckpointStateVars(self, timeIndex, timeVal):
+        """
+        Restore or recompute the state variables for the given time index using the
+        checkpoints saved in the primal, and assign them to both self.solver and self.solverAD.
+        This replaces readStateVars when unsteadyAdjoint->checkpointMethod is not None.
+        NOTE: timeIndex needs to be called in descending order, i.e., from endTimeIndex to 1
+        """
+
+        # restore the states in self.solver. This may re-run the primal from the
+        # closest checkpoint
+        self.solver.restoreCheckpointStateVars(timeIndex)
+
+        # now copy all the time levels from self.solver to self.solverAD
+        # NOTE: we need to call setTime before assigning the oldTime fields
+        self.solverAD.setTime(timeVal, timeIndex)
+        stateVec = self.wVec.duplicate()
+        stateBCVec = PETSc.Vec().createSeq(self.solver.getNLocalAdjointBoundaryStates(), bsize=1, comm=PETSc.COMM_SELF)
+        for oldTimeLevel in [0, 1, 2]:
+            self.solver.getTimeLevelStateVecs(oldTimeLevel, stateVec, stateBCVec)
+            self.solverAD.setTimeLevelStateVecs(oldTimeLevel, stateVec, stateBCVec)
+        self.solverAD.updateStateBoundaryConditions()
+
+        # assign the state from OF field to wVec so that the wVec
+        # is update to date for unsteady adjoint
+        self.solver.ofField2StateVec(self.wVec)
+
     def calcTotalDerivsBC(self, objFuncName, designVarName, dFScaling=1.0, accumulateTotal=False):
 
         nDVs = 1
@@ -2219,6 +2451,315 @@ class PYDAFOAM(object):
             else:
                 self.adjTotalDeriv[objFuncName][designVarName][i] = totalDerivArray[i]
 
+    def calcdRdWTPC(self, dRdWTPC):
+        """
+        Compute the preconditioner matrix dRdWTPC using the states in self.wVec. If
+        adjPartDerivMethod=batchedAD, it is computed by self.solverAD using the forward
+        vector mode of the residual tape, otherwise, it is computed by self.solver using
+        coloring accelerated finite-difference
+
+        Input:
+        ------
+        dRdWTPC: the PC mat to compute, created by PETSc.Mat().create
+        """
+
+        if self.getOption("adjPartDerivMethod") == "batchedAD":
+            self.solverAD.calcdRdWT(self.xvVec, self.wVec, 1, dRdWTPC)
+        else:
+            self.solver.calcdRdWT(self.xvVec, self.wVec, 1, dRdWTPC)
+
+    def _checkBatchedADModels(self):
+        """
+        Make sure no model with a reverse-mode-only AD function is active when using
+        adjPartDerivMethod=batchedAD, which evaluates the AD tape in forward mode
+        """
+
+        if self.getOption("regressionModel")["active"]:
+            raise Error("adjPartDerivMethod=batchedAD does not support regressionModel-active=True")
+        if self.getOption("tensorflow")["active"]:
+            raise Error("adjPartDerivMethod=batchedAD does not support tensorflow-active=True (e.g., kOmegaSSTFIML)")
+
+    def benchmarkdRdWTPC(self):
+        """
+        Compute the preconditioner matrix dRdWTPC using both FD (self.solver) and batchedAD
+        (self.solverAD) for the states in self.wVec, and print their runtime and the relative
+        difference between the two matrices. The throughput (colors/s) of each method is
+        also printed by the OpenFOAM layer. This requires useAD-mode=reverse
+
+        Output:
+        -------
+        runTimes: a dict with the runtime for FD and batchedAD
+
+        relDiff: the relative difference (Frobenius norm) between the two PC mats
+        """
+
+        if self.getOption("useAD")["mode"] != "reverse":
+            raise Error("benchmarkdRdWTPC only supports useAD->mode=reverse")
+        self._checkBatchedADModels()
+
+        adjPartDerivMethod = self.getOption("adjPartDerivMethod")
+
+        runTimes = {}
+        PCMats = {}
+        for method in ["FD", "batchedAD"]:
+            self.setOption("adjPartDerivMethod", method)
+            self.updateDAOption()
+            PCMats[method] = PETSc.Mat().create(PETSc.COMM_WORLD)
+            self.comm.Barrier()
+            t0 = time.time()
+            self.calcdRdWTPC(PCMats[method])
+            self.comm.Barrier()
+            runTimes[method] = time.time() - t0
+
+        # relative difference, the FD and batchedAD mats have the same nonzero pattern
+        diffMat = PCMats["batchedAD"].duplicate(copy=True)
+        diffMat.axpy(-1.0, PCMats["FD"])
+        relDiff = diffMat.norm() / PCMats["FD"].norm()
+
+        Info("dRdWTPC benchmark: FD %f s, batchedAD %f s, speedup %f, relative difference %e"
+             % (runTimes["FD"], runTimes["batchedAD"], runTimes["FD"] / runTimes["batchedAD"], relDiff))
+
+        for method in PCMats:
+            PCMats[method].destroy()
+        diffMat.destroy()
+
+        self.setOption("adjPartDerivMethod", adjPartDerivMethod)
+        self.updateDAOption()
+
+        return runTimes, relDiff
+
+    def getAdjointKSP(self, ksp, objFuncName, PCMat):
+        """
+        Return the KSP object to solve the adjoint equation of objFuncName. For
+        adjEqnOption-recycleMode=gcrodr, we keep one KSP object for each objFunc
+        such that its deflation subspace is reused in the next adjoint solution.
+        Otherwise, we return the input ksp
+
+        Input:
+        ------
+        ksp: the KSP object shared by all objFuncs
+
+        objFuncName: the name of the objective function
+
+        PCMat: the preconditioner matrix
+        """
+
+        if self.getOption("adjEqnOption")["recycleMode"] != "gcrodr":
+            return ksp
+
+        if objFuncName not in self.adjRecycleKSPs:
+            self.adjRecycleKSPs[objFuncName] = PETSc.KSP().create(PETSc.COMM_WORLD)
+            self.solverAD.createMLRKSPMatrixFree(PCMat, self.adjRecycleKSPs[objFuncName])
+        else:
+            # the matrix-free dRdWT is re-created for each adjoint solution, so we need to update
+            # the operators. The recycled subspace is kept in the KSP object
+            self.solverAD.updateKSPPCMat(PCMat, self.adjRecycleKSPs[objFuncName])
+
+        return self.adjRecycleKSPs[objFuncName]
+
+    def destroyAdjointKSPs(self):
+        """
+        Destroy the KSP objects kept for adjEqnOption-recycleMode=gcrodr. This needs to be
+        called wherever the shared KSP object (self.ksp) or its PC mat is rebuilt or destroyed,
+        otherwise the recycled KSP objects and the PC mats they reference are never freed.
+        The KSP objects will be re-created in the next getAdjointKSP call
+        """
+
+        for objFuncName in self.adjRecycleKSPs:
+            self.adjRecycleKSPs[objFuncName].destroy()
+        self.adjRecycleKSPs = {}
+
+    def solveAdjointLinearEqn(self, ksp, dFdW, objFuncName):
+        """
+        Solve the adjoint equation dRdWT * psi = dFdW for objFuncName using reverse-mode AD.
+        For adjEqnOption-recycleMode=projection, we warm start the solution from the recycle
+        space of objFuncName, i.e., the last recycleDim adjoint solutions, and then append
+        the new solution to the recycle space
+
+        Input:
+        ------
+        ksp: the KSP object
+
+        dFdW: the right-hand-side vector
+
+        objFuncName: the name of the objective function
+
+        Output:
+        -------
+        self.adjVectors[objFuncName]: the adjoint vector psi
+
+        Return 0 if the adjoint solution is successful, otherwise 1
+        """
+
+        psi = self.adjVectors[objFuncName]
+
+        # the iterations will be reported against the previous solution of objFuncName
+        self.solverAD.setLinearEqnName(objFuncName.encode())
+
+        if self.getOption("adjEqnOption")["recycleMode"] != "projection":
+            return self.solverAD.solveLinearEqn(ksp, dFdW, psi)
+
+        recycleVecs = self.adjRecycleVecs.setdefault(objFuncName, [])
+
+        if len(recycleVecs) == 0:
+            fail = self.solverAD.solveLinearEqn(ksp, dFdW, psi)
+        else:
+            # assemble the recycle space as the columns of a dense mat
+            wSize = self.solver.getNLocalAdjointStates()
+            recycleMat = PETSc.Mat().createDense(
+                ((wSize, PETSc.DECIDE), (PETSc.DECIDE, len(recycleVecs))), comm=PETSc.COMM_WORLD
+            )
+            recycleMat.setUp()
+            recycleArray = recycleMat.getDenseArray()
+            for colI, vec in enumerate(recycleVecs):
+                recycleArray[:, colI] = vec.getArray()
+            recycleMat.assemble()
+            fail = self.solverAD.solveLinearEqnRecycle(ksp, dFdW, recycleMat, psi)
+            recycleMat.destroy()
+
+        # update the recycle space, we keep the latest recycleDim solutions
+        recycleVecs.append(psi.copy())
+        if len(recycleVecs) > self.getOption("adjEqnOption")["recycleDim"]:
+            recycleVecs.pop(0).destroy()
+
+        return fail
+
+    def solveAdjointMultiRHS(self, ksp):
+        """
+        Solve the adjoint equations for all objective functions in self.objFuncNames4Adj
+        together using reverse-mode AD. The dFdW vectors are assembled as the columns of
+        a dense matrix, and the solutions are assigned to self.adjVectors
+
+        Input:
+        ------
+        ksp: the KSP object created by createMLRKSPMatrixFree
+        """
+
+        if self.getOption("useAD")["mode"] != "reverse":
+            raise Error("solveAdjointMultiRHS only supports useAD->mode=reverse")
+
+        objFuncDict = self.getOption("objFunc")
+        objFuncNames = [objFuncName for objFuncName in objFuncDict if objFuncName in self.objFuncNames4Adj]
+        nRHS = len(objFuncNames)
+        if nRHS == 0:
+            return
+
+        wSize = self.solver.getNLocalAdjointStates()
+        rhsMat = PETSc.Mat().createDense(((wSize, PETSc.DECIDE), (PETSc.DECIDE, nRHS)), comm=PETSc.COMM_WORLD)
+        rhsMat.setUp()
+        solMat = rhsMat.duplicate()
+        rhsArray = rhsMat.getDenseArray()
+        solArray = solMat.getDenseArray()
+
+        dFdW = PETSc.Vec().create(PETSc.COMM_WORLD)
+        dFdW.setSizes((wSize, PETSc.DECIDE), bsize=1)
+        dFdW.setFromOptions()
+        for colI, objFuncName in enumerate(objFuncNames):
+            self.solverAD.calcdFdWAD(self.xvVec, self.wVec, objFuncName.encode(), dFdW)
+            rhsArray[:, colI] = dFdW.getArray()
+            # the current adjoint vectors are the initial guess if useNonZeroInitGuess is set
+            solArray[:, colI] = self.adjVectors[objFuncName].getArray()
+        dFdW.destroy()
+        rhsMat.assemble()
+        solMat.assemble()
+
+        self.adjointFail = self.solverAD.solveLinearEqnMultiRHS(ksp, rhsMat, solMat)
+
+        solArray = solMat.getDenseArray()
+        for colI, objFuncName in enumerate(objFuncNames):
+            self.adjVectors[objFuncName].setArray(solArray[:, colI])
+            self.adjVectors[objFuncName].assemble()
+
+        rhsMat.destroy()
+        solMat.destroy()
+
+    def _updateUnsteadyPCMat(self, n, timeVal, endTimeIndex, PCMatUpdate, ksp, PCMat):
+        """
+        Switch the KSP to the pre-computed PC mat for timeVal if any, or update the PC mat
+        values using OpenFOAM's fvMatrix every PCMatUpdateInterval steps. Return the PC mat
+        used for this time step. This is called by solveAdjointUnsteady
+        """
+
+        # check if we need to update the PC Mat vals or use the pre-computed PC matrix
+        if str(timeVal) in list(self.dRdWTPCUnsteady.keys()):
+            Info("Using pre-computed KSP PC mat for %f" % timeVal)
+            PCMat = self.dRdWTPCUnsteady[str(timeVal)]
+            self.solverAD.updateKSPPCMat(PCMat, ksp)
+        if n % PCMatUpdate == 0 and n < endTimeIndex:
+            # udpate part of the PC mat
+            Info("Updating dRdWTPC mat value using OF fvMatrix")
+            self.solver.calcPCMatWithFvMatrix(PCMat)
+
+        return PCMat
+
+    def _solveAdjointUnsteadyStep(self, objFuncName, n, timeVal, ddtSchemeOrder, ksp, PCMat, dFdW, dRdWOldTPsi):
+        """
+        Solve the unsteady adjoint of objFuncName for the time index n and accumulate the totals.
+        The states for this time step need to be assigned before calling this function.
+        dRdWOldTPsi is the list [dRdW0TPsi, dRdW00TPsi, dRdW00TPsiBuffer] for objFuncName, which
+        is used and updated for the previous time step. This is called by solveAdjointUnsteady
+        """
+
+        Info("---- Solving unsteady adjoint for %s. t = %f ----" % (objFuncName, timeVal))
+
+        designVarDict = self.getOption("designVar")
+
+        # calculate dFdW, if time index is within the unsteady objective function
+        # index range, prescribed in unsteadyAdjointDict, we calculate dFdW
+        # otherwise, we use dFdW=0 because the unsteady obj does not depend
+        # on the state at this time index
+        dFScaling = 1.0
+        if n >= self.solver.getUnsteadyObjFuncStartTimeIndex() and n <= self.solver.getUnsteadyObjFuncEndTimeIndex():
+            dFScaling = self.solver.getObjFuncUnsteadyScaling()
+        else:
+            dFScaling = 0.0
+
+        self.solverAD.calcdFdWAD(self.xvVec, self.wVec, objFuncName.encode(), dFdW)
+        dFdW.scale(dFScaling)
+
+        # do dFdW - dRdW0TPsi - dRdW00TPsi
+        if ddtSchemeOrder == 1:
+            dFdW.axpy(-1.0, dRdWOldTPsi[0])
+        elif ddtSchemeOrder == 2:
+            dFdW.axpy(-1.0, dRdWOldTPsi[0])
+            dFdW.axpy(-1.0, dRdWOldTPsi[1])
+            # now copy the buffer vec dRdW00TPsiBuffer to dRdW00TPsi for the next time step
+            dRdWOldTPsi[2].copy(dRdWOldTPsi[1])
+        else:
+            raise Error("ddtSchemeOrder not valid!" % ddtSchemeOrder)
+
+        # now solve the adjoint eqn
+        self.adjointFail = self.solveAdjointLinearEqn(self.getAdjointKSP(ksp, objFuncName, PCMat), dFdW, objFuncName)
+
+        # loop over all the design vars and accumulate totals
+        for designVarName in designVarDict:
+            Info("Computing total derivatives of %s wrt %s" % (objFuncName, designVarName))
+            if designVarDict[designVarName]["designVarType"] == "BC":
+                self.calcTotalDerivsBC(objFuncName, designVarName, dFScaling, True)
+            elif designVarDict[designVarName]["designVarType"] == "AOA":
+                self.calcTotalDerivsAOA(objFuncName, designVarName, dFScaling, True)
+            elif designVarDict[designVarName]["designVarType"] == "FFD":
+                self.calcTotalDerivsFFD(objFuncName, designVarName, dFScaling, True)
+            elif designVarDict[designVarName]["designVarType"] in ["ACTL", "ACTP", "ACTD"]:
+                designVarType = designVarDict[designVarName]["designVarType"]
+                self.calcTotalDerivsACT(objFuncName, designVarName, designVarType, dFScaling, True)
+            elif designVarDict[designVarName]["designVarType"] == "Field":
+                fieldType = designVarDict[designVarName]["fieldType"]
+                self.calcTotalDerivsField(objFuncName, designVarName, fieldType, dFScaling, True)
+            elif designVarDict[designVarName]["designVarType"] == "RegPar":
+                self.calcTotalDerivsRegPar(objFuncName, designVarName, dFScaling, True)
+            else:
+                raise Error("designVarType not valid!")
+
+        # we need to calculate dRdW0TPsi for the previous time step
+        if ddtSchemeOrder == 1:
+            self.solverAD.calcdRdWOldTPsiAD(1, self.adjVectors[objFuncName], dRdWOldTPsi[0])
+        elif ddtSchemeOrder == 2:
+            # do the same for the previous previous step, but we need to save it to a buffer vec
+            # because dRdW00TPsi will be used 2 steps before
+            self.solverAD.calcdRdWOldTPsiAD(1, self.adjVectors[objFuncName], dRdWOldTPsi[0])
+            self.solverAD.calcdRdWOldTPsiAD(2, self.adjVectors[objFuncName], dRdWOldTPsi[2])
+
     def solveAdjointUnsteady(self):
         """
         Run adjoint solver to compute the total derivs for unsteady solvers
@@ -2274,11 +2815,17 @@ class PYDAFOAM(object):
 
         ddtSchemeOrder = self.solver.getDdtSchemeOrder()
 
+        # whether to recompute the states from the checkpoints instead of reading them from the disk
+        useCheckpointing = self.getOption("unsteadyAdjoint")["checkpointMethod"] != "None"
+
         # read the latest solution
-        self.solver.setTime(endTime, endTimeIndex)
-        self.solverAD.setTime(endTime, endTimeIndex)
-        # now we can read the variables
-        self.readStateVars(endTime, deltaT)
+        if useCheckpointing:
+            self.restoreCheckpointStateVars(endTimeIndex, endTime)
+        else:
+            self.solver.setTime(endTime, endTimeIndex)
+            self.solverAD.setTime(endTime, endTimeIndex)
+            # now we can read the variables
+            self.readStateVars(endTime, deltaT)
 
         # now we can print the residual for the endTime state
         self.solverAD.calcPrimalResidualStatistics("print".encode())
@@ -2292,21 +2839,18 @@ class PYDAFOAM(object):
             self.dRdWTPCUnsteady = {}
 
             # always calculate the PC mat for the endTime
-            self.solver.setTime(endTime, endTimeIndex)
-            self.solverAD.setTime(endTime, endTimeIndex)
-            # now we can read the variables
-            self.readStateVars(endTime, deltaT)
-            # calc the preconditioner mat for endTime
+            # NOTE: the states for endTime have been assigned above
             Info("Pre-Computing preconditiner mat for t = %f" % endTime)
             dRdWTPC = PETSc.Mat().create(PETSc.COMM_WORLD)
-            self.solver.calcdRdWT(self.xvVec, self.wVec, 1, dRdWTPC)
+            self.calcdRdWTPC(dRdWTPC)
             # always update the PC mat values using OpenFOAM's fvMatrix
             self.solver.calcPCMatWithFvMatrix(dRdWTPC)
             self.dRdWTPCUnsteady[str(endTime)] = dRdWTPC
 
             # if we define some extra PCMat in PCMatPrecomputeInterval, calculate them here
-            # and set them to the self.dRdWTPCUnsteady dict
-            if objFuncEndTimeIndex > PCMatPrecompute:
+            # and set them to the self.dRdWTPCUnsteady dict. With checkpointing, the states can only
+            # be restored in descending order, so we compute these PC mats in the adjoint loop below
+            if objFuncEndTimeIndex > PCMatPrecompute and not useCheckpointing:
                 for timeIndex in range(objFuncEndTimeIndex - 1, 0, -1):
                     if timeIndex % PCMatPrecompute == 0:
                         t = timeIndex * deltaT
@@ -2319,7 +2863,7 @@ class PYDAFOAM(object):
 
                         # calc the preconditioner mat
                         dRdWTPC = PETSc.Mat().create(PETSc.COMM_WORLD)
-                        self.solver.calcdRdWT(self.xvVec, self.wVec, 1, dRdWTPC)
+                        self.calcdRdWTPC(dRdWTPC)
                         # always update the PC mat values using OpenFOAM's fvMatrix
                         self.solver.calcPCMatWithFvMatrix(dRdWTPC)
                         self.dRdWTPCUnsteady[str(t)] = dRdWTPC
@@ -2337,30 +2881,54 @@ class PYDAFOAM(object):
         dFdW = PETSc.Vec().create(PETSc.COMM_WORLD)
         dFdW.setSizes((wSize, PETSc.DECIDE), bsize=1)
         dFdW.setFromOptions()
-        # initialize the adjoint vecs
-        dRdW0TPsi = dFdW.duplicate()
-        dRdW00TPsi = dFdW.duplicate()
-        dRdW00TPsiBuffer = dFdW.duplicate()
+        # initialize the adjoint vecs for all objFuncs
+        objFuncNames = [objFuncName for objFuncName in objFuncDict if objFuncName in self.objFuncNames4Adj]
+        dRdWOldTPsi = {}
+        for objFuncName in objFuncNames:
+            # dRdW0TPsi, dRdW00TPsi, and dRdW00TPsiBuffer
+            dRdWOldTPsi[objFuncName] = [dFdW.duplicate(), dFdW.duplicate(), dFdW.duplicate()]
+            for vec in dRdWOldTPsi[objFuncName]:
+                vec.zeroEntries()
 
         # we need to reset the total derivative every time we call solveAdjointUnsteady!
         self.adjTotalDeriv = self._initializeAdjTotalDeriv()
 
-        # loop over all objFunc, calculate dFdW, and solve the adjoint
-        for objFuncName in objFuncDict:
-            if objFuncName in self.objFuncNames4Adj:
-                # zero the vecs
-                dRdW0TPsi.zeroEntries()
-                dRdW00TPsi.zeroEntries()
-                dRdW00TPsiBuffer.zeroEntries()
-                dFdW.zeroEntries()
-                # get the dFdW scaling factor
-                # loop over all time steps and solve the adjoint and accumulate the totals
+        if useCheckpointing:
+            # with checkpointing, the states can only be restored in descending time order, so we
+            # loop over all time steps first and then loop over all objFuncs. In this way, the states
+            # for each time step are recomputed from the checkpoints only once
+            for n in range(endTimeIndex, 0, -1):
+
+                timeVal = n * deltaT
+
+                # restore the states from the checkpoints, this sets the time value and index and may
+                # re-run the primal from the closest checkpoint
+                self.restoreCheckpointStateVars(n, timeVal)
+
+                # the extra PC mats are computed when the states become available
+                if n < endTimeIndex and n % PCMatPrecompute == 0:
+                    if str(timeVal) not in list(self.dRdWTPCUnsteady.keys()):
+                        Info("Pre-Computing preconditiner mat for t = %f" % timeVal)
+                        dRdWTPC = PETSc.Mat().create(PETSc.COMM_WORLD)
+                        self.calcdRdWTPC(dRdWTPC)
+                        # always update the PC mat values using OpenFOAM's fvMatrix
+                        self.solver.calcPCMatWithFvMatrix(dRdWTPC)
+                        self.dRdWTPCUnsteady[str(timeVal)] = dRdWTPC
+
+                PCMat = self._updateUnsteadyPCMat(n, timeVal, endTimeIndex, PCMatUpdate, ksp, PCMat)
+
+                for objFuncName in objFuncNames:
+                    self._solveAdjointUnsteadyStep(
+                        objFuncName, n, timeVal, ddtSchemeOrder, ksp, PCMat, dFdW, dRdWOldTPsi[objFuncName]
+                    )
+        else:
+            # loop over all objFunc, and for each objFunc, loop over all time steps backward,
+            # read the states, solve the adjoint, and accumulate the totals
+            for objFuncName in objFuncNames:
                 for n in range(endTimeIndex, 0, -1):
 
                     timeVal = n * deltaT
 
-                    Info("---- Solving unsteady adjoint for %s. t = %f ----" % (objFuncName, timeVal))
-
                     # set the time value and index in the OpenFOAM layer. Note: this is critical
                     # because if timeIndex < 2, OpenFOAM will not use the oldTime.oldTime for 2nd
                     # ddtScheme and mess up the totals. Check backwardDdtScheme.C
@@ -2370,71 +2938,11 @@ class PYDAFOAM(object):
                     # read the state, state.oldTime, etc and update self.wVec for this time instance
                     self.readStateVars(timeVal, deltaT)
 
-                    # calculate dFdW, if time index is within the unsteady objective function
-                    # index range, prescribed in unsteadyAdjointDict, we calculate dFdW
-                    # otherwise, we use dFdW=0 because the unsteady obj does not depend
-                    # on the state at this time index
-                    dFScaling = 1.0
-                    if n >= objFuncStartTimeIndex and n <= objFuncEndTimeIndex:
-                        dFScaling = self.solver.getObjFuncUnsteadyScaling()
-                    else:
-                        dFScaling = 0.0
-
-                    self.solverAD.calcdFdWAD(self.xvVec, self.wVec, objFuncName.encode(), dFdW)
-                    dFdW.scale(dFScaling)
-
-                    # do dFdW - dRdW0TPsi - dRdW00TPsi
-                    if ddtSchemeOrder == 1:
-                        dFdW.axpy(-1.0, dRdW0TPsi)
-                    elif ddtSchemeOrder == 2:
-                        dFdW.axpy(-1.0, dRdW0TPsi)
-                        dFdW.axpy(-1.0, dRdW00TPsi)
-                        # now copy the buffer vec dRdW00TPsiBuffer to dRdW00TPsi for the next time step
-                        dRdW00TPsi = dRdW00TPsiBuffer.copy()
-                    else:
-                        raise Error("ddtSchemeOrder not valid!" % ddtSchemeOrder)
-
-                    # check if we need to update the PC Mat vals or use the pre-computed PC matrix
-                    if str(timeVal) in list(self.dRdWTPCUnsteady.keys()):
-                        Info("Using pre-computed KSP PC mat for %f" % timeVal)
-                        PCMat = self.dRdWTPCUnsteady[str(timeVal)]
-                        self.solverAD.updateKSPPCMat(PCMat, ksp)
-                    if n % PCMatUpdate == 0 and n < endTimeIndex:
-                        # udpate part of the PC mat
-                        Info("Updating dRdWTPC mat value using OF fvMatrix")
-                        self.solver.calcPCMatWithFvMatrix(PCMat)
-
-                    # now solve the adjoint eqn
-                    self.adjointFail = self.solverAD.solveLinearEqn(ksp, dFdW, self.adjVectors[objFuncName])
-
-                    # loop over all the design vars and accumulate totals
-                    for designVarName in designVarDict:
-                        Info("Computing total derivatives of %s wrt %s" % (objFuncName, designVarName))
-                        if designVarDict[designVarName]["designVarType"] == "BC":
-                            self.calcTotalDerivsBC(objFuncName, designVarName, dFScaling, True)
-                        elif designVarDict[designVarName]["designVarType"] == "AOA":
-                            self.calcTotalDerivsAOA(objFuncName, designVarName, dFScaling, True)
-                        elif designVarDict[designVarName]["designVarType"] == "FFD":
-                            self.calcTotalDerivsFFD(objFuncName, designVarName, dFScaling, True)
-                        elif designVarDict[designVarName]["designVarType"] in ["ACTL", "ACTP", "ACTD"]:
-                            designVarType = designVarDict[designVarName]["designVarType"]
-                            self.calcTotalDerivsACT(objFuncName, designVarName, designVarType, dFScaling, True)
-                        elif designVarDict[designVarName]["designVarType"] == "Field":
-                            fieldType = designVarDict[designVarName]["fieldType"]
-                            self.calcTotalDerivsField(objFuncName, designVarName, fieldType, dFScaling, True)
-                        elif designVarDict[designVarName]["designVarType"] == "RegPar":
-                            self.calcTotalDerivsRegPar(objFuncName, designVarName, dFScaling, True)
-                        else:
-                            raise Error("designVarType not valid!")
+                    PCMat = self._updateUnsteadyPCMat(n, timeVal, endTimeIndex, PCMatUpdate, ksp, PCMat)
 
-                    # we need to calculate dRdW0TPsi for the previous time step
-                    if ddtSchemeOrder == 1:
-                        self.solverAD.calcdRdWOldTPsiAD(1, self.adjVectors[objFuncName], dRdW0TPsi)
-                    elif ddtSchemeOrder == 2:
-                        # do the same for the previous previous step, but we need to save it to a buffer vec
-                        # because dRdW00TPsi will be used 2 steps before
-                        self.solverAD.calcdRdWOldTPsiAD(1, self.adjVectors[objFuncName], dRdW0TPsi)
-                        self.solverAD.calcdRdWOldTPsiAD(2, self.adjVectors[objFuncName], dRdW00TPsiBuffer)
+                    self._solveAdjointUnsteadyStep(
+                        objFuncName, n, timeVal, ddtSchemeOrder, ksp, PCMat, dFdW, dRdWOldTPsi[objFuncName]
+                    )
 
         self.nSolveAdjoints += 1
 
@@ -2499,7 +3007,7 @@ class PYDAFOAM(object):
             adjPCLag = self.getOption("adjPCLag")
             if self.nSolveAdjoints == 1 or (self.nSolveAdjoints - 1) % adjPCLag == 0:
                 self.dRdWTPC = PETSc.Mat().create(PETSc.COMM_WORLD)
-                self.solver.calcdRdWT(self.xvVec, self.wVec, 1, self.dRdWTPC)
+                self.calcdRdWTPC(self.dRdWTPC)
 
         # Initialize the KSP object
         ksp = PETSc.KSP().create(PETSc.COMM_WORLD)
@@ -2511,23 +3019,29 @@ class PYDAFOAM(object):
         # loop over all objFunc, calculate dFdW, and solve the adjoint
         objFuncDict = self.getOption("objFunc")
         wSize = self.solver.getNLocalAdjointStates()
-        for objFuncName in objFuncDict:
-            if objFuncName in self.objFuncNames4Adj:
-                dFdW = PETSc.Vec().create(PETSc.COMM_WORLD)
-                dFdW.setSizes((wSize, PETSc.DECIDE), bsize=1)
-                dFdW.setFromOptions()
-                if self.getOption("useAD")["mode"] == "fd":
-                    self.solver.calcdFdW(self.xvVec, self.wVec, objFuncName.encode(), dFdW)
-                elif self.getOption("useAD")["mode"] == "reverse":
-                    self.solverAD.calcdFdWAD(self.xvVec, self.wVec, objFuncName.encode(), dFdW)
-
-                # Initialize the adjoint vector psi and solve for it
-                if self.getOption("useAD")["mode"] == "fd":
-                    self.adjointFail = self.solver.solveLinearEqn(ksp, dFdW, self.adjVectors[objFuncName])
-                elif self.getOption("useAD")["mode"] == "reverse":
-                    self.adjointFail = self.solverAD.solveLinearEqn(ksp, dFdW, self.adjVectors[objFuncName])
+        if self.getOption("useAD")["mode"] == "reverse" and self.getOption("adjEqnOption")["multiRHS"]:
+            # solve the adjoint for all objFuncs together
+            self.solveAdjointMultiRHS(ksp)
+        else:
+            for objFuncName in objFuncDict:
+                if objFuncName in self.objFuncNames4Adj:
+                    dFdW = PETSc.Vec().create(PETSc.COMM_WORLD)
+                    dFdW.setSizes((wSize, PETSc.DECIDE), bsize=1)
+                    dFdW.setFromOptions()
+                    if self.getOption("useAD")["mode"] == "fd":
+                        self.solver.calcdFdW(self.xvVec, self.wVec, objFuncName.encode(), dFdW)
+                    elif self.getOption("useAD")["mode"] == "reverse":
+                        self.solverAD.calcdFdWAD(self.xvVec, self.wVec, objFuncName.encode(), dFdW)
+
+                    # Initialize the adjoint vector psi and solve for it
+                    if self.getOption("useAD")["mode"] == "fd":
+                        self.adjointFail = self.solver.solveLinearEqn(ksp, dFdW, self.adjVectors[objFuncName])
+                    elif self.getOption("useAD")["mode"] == "reverse":
+                        self.adjointFail = self.solveAdjointLinearEqn(
+                            self.getAdjointKSP(ksp, objFuncName, self.dRdWTPC), dFdW, objFuncName
+                        )
 
-                dFdW.destroy()
+                    dFdW.destroy()
 
         ksp.destroy()
         if self.getOption("useAD")["mode"] == "fd":
@@ -2732,6 +3246,7 @@ class PYDAFOAM(object):
 
         # we destroy dRdWTPC only when we need to recompute it next time
         if (self.nSolveAdjoints - 1) % adjPCLag == 0:
+            self.destroyAdjointKSPs()
             self.dRdWTPC.destroy()
 
         return
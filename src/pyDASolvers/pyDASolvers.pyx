@@ -14,6 +14,7 @@
 
 # for using Petsc
 from petsc4py.PETSc cimport Vec, PetscVec, Mat, PetscMat, KSP, PetscKSP
+from libcpp.string cimport string
 cimport numpy as np
 np.import_array() # initialize C API to call PyArray_SimpleNewFromData
 
@@ -53,6 +54,10 @@ cdef extern from "DASolvers.H" namespace "Foam":
         void createMLRKSPMatrixFree(PetscMat, PetscKSP)
         void updateKSPPCMat(PetscMat, PetscKSP)
         void solveLinearEqn(PetscKSP, PetscVec, PetscVec)
+        int solveLinearEqnRecycle(PetscKSP, PetscVec, PetscMat, PetscVec)
+        void setLinearEqnName(char *)
+        int getLinearEqnIters(char *)
+        int solveLinearEqnMultiRHS(PetscKSP, PetscMat, PetscMat)
         void calcdRdBC(PetscVec, PetscVec, char *, PetscMat)
         void calcdFdBC(PetscVec, PetscVec, char *, char *, PetscVec)
         void calcdFdBCAD(PetscVec, PetscVec, char *, char *, PetscVec)
@@ -133,6 +138,9 @@ cdef extern from "DASolvers.H" namespace "Foam":
         void calcPrimalResidualStatistics(char *)
         double getForwardADDerivVal(char *)
         void calcResidualVec(PetscVec)
+        void benchmarkStateTransfer(int)
+        string getProfileJSON()
+        void resetProfile()
         void setPrimalBoundaryConditions(int)
         void calcFvSource(char *, PetscVec, PetscVec, PetscVec, PetscVec, PetscVec, PetscVec, PetscVec)
         void calcdFvSourcedInputsTPsiAD(char *, char *, PetscVec, PetscVec, PetscVec, PetscVec, PetscVec, PetscVec, PetscVec, PetscVec)
@@ -142,6 +150,10 @@ cdef extern from "DASolvers.H" namespace "Foam":
         int runFPAdj(PetscVec, PetscVec, PetscVec, PetscVec)
         void initTensorFlowFuncs(pyComputeInterface, void *, pyJacVecProdInterface, void *)
         void readStateVars(double, int)
+        void restoreCheckpointStateVars(int)
+        void getTimeLevelStateVecs(int, PetscVec, PetscVec)
+        void setTimeLevelStateVecs(int, PetscVec, PetscVec)
+        void updateStateBoundaryConditions()
         void calcPCMatWithFvMatrix(PetscMat)
         double getEndTime()
         double getDeltaT()
@@ -228,6 +240,18 @@ cdef class pyDASolvers:
     def solveLinearEqn(self, KSP myKSP, Vec rhsVec, Vec solVec):
         self._thisptr.solveLinearEqn(myKSP.ksp, rhsVec.vec, solVec.vec)
 
+    def solveLinearEqnRecycle(self, KSP myKSP, Vec rhsVec, Mat recycleMat, Vec solVec):
+        return self._thisptr.solveLinearEqnRecycle(myKSP.ksp, rhsVec.vec, recycleMat.mat, solVec.vec)
+
+    def setLinearEqnName(self, eqnName):
+        self._thisptr.setLinearEqnName(eqnName)
+
+    def getLinearEqnIters(self, eqnName):
+        return self._thisptr.getLinearEqnIters(eqnName)
+
+    def solveLinearEqnMultiRHS(self, KSP myKSP, Mat rhsMat, Mat solMat):
+        return self._thisptr.solveLinearEqnMultiRHS(myKSP.ksp, rhsMat.mat, solMat.mat)
+
     def calcdRdBC(self, Vec xvVec, Vec wVec, designVarName, Mat dRdBC):
         self._thisptr.calcdRdBC(xvVec.vec, wVec.vec, designVarName, dRdBC.mat)
     
@@ -601,12 +625,33 @@ cdef class pyDASolvers:
     def calcResidualVec(self, Vec resVec):
         self._thisptr.calcResidualVec(resVec.vec)
     
+    def benchmarkStateTransfer(self, nRepeats):
+        self._thisptr.benchmarkStateTransfer(nRepeats)
+    
+    def getProfileJSON(self):
+        return self._thisptr.getProfileJSON().decode()
+    
+    def resetProfile(self):
+        self._thisptr.resetProfile()
+    
     def setPrimalBoundaryConditions(self, printInfo):
         self._thisptr.setPrimalBoundaryConditions(printInfo)
     
     def readStateVars(self, timeVal, timeLevel):
         self._thisptr.readStateVars(timeVal, timeLevel)
     
+    def restoreCheckpointStateVars(self, timeIndex):
+        self._thisptr.restoreCheckpointStateVars(timeIndex)
+    
+    def getTimeLevelStateVecs(self, oldTimeLevel, Vec stateVec, Vec stateBCVec):
+        self._thisptr.getTimeLevelStateVecs(oldTimeLevel, stateVec.vec, stateBCVec.vec)
+    
+    def setTimeLevelStateVecs(self, oldTimeLevel, Vec stateVec, Vec stateBCVec):
+        self._thisptr.setTimeLevelStateVecs(oldTimeLevel, stateVec.vec, stateBCVec.vec)
+    
+    def updateStateBoundaryConditions(self):
+        self._thisptr.updateStateBoundaryConditions()
+    
     def calcPCMatWithFvMatrix(self, Mat PCMat):
         self._thisptr.calcPCMatWithFvMatrix(PCMat.mat)
     
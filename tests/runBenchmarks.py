@@ -0,0 +1,196 @@
+#!/usr/bin/env python
+"""
+Run the scaling benchmarks for the primal and adjoint solvers
+
+We refine the meshes of the test cases in input (uniform refinement with refineMesh)
+to get increasing mesh sizes, run the primal, coloring, and adjoint with the profiler
+active, and collect the wall time of the hot-path phases, the number of KSP iterations,
+and the peak memory in DAFoam_Benchmark.json. Compare two DAFoam_Benchmark.json files
+to see the speedup of a change.
+
+Usage:
+    python runBenchmarks.py [nProcs] [maxRefineLevel]
+"""
+
+import sys
+import os
+import json
+import subprocess
+
+# the test cases to run, we use the same setup as the regression tests. NOTE: NACA0012Unsteady
+# has no 0.* template, so we must not remove its 0 folder
+benchmarkCases = {
+    "DASimpleFoam": {
+        "case": "NACA0012",
+        "setup": [
+            "rm -rf 0 processor*",
+            "cp -r 0.incompressible 0",
+            "cp -r system.incompressible system",
+            "cp -r constant/turbulenceProperties.sst constant/turbulenceProperties",
+        ],
+        "primalBC": {"U0": {"variable": "U", "patches": ["inout"], "value": [10.0, 0.0, 0.0]}},
+        "designSurfaces": ["wing"],
+        "normalizeStates": {"U": 10.0, "p": 50.0, "k": 0.18, "omega": 1225.0, "phi": 1.0},
+    },
+    "DARhoSimpleFoam": {
+        "case": "CurvedCubeSnappyHexMesh",
+        "setup": [
+            "rm -rf 0 processor*",
+            "cp -r 0.compressible 0",
+            "cp -r constant/turbulenceProperties.sa constant/turbulenceProperties",
+        ],
+        "primalBC": {
+            "UIn": {"variable": "U", "patches": ["inlet"], "value": [50.0, 0.0, 0.0]},
+            "p0": {"variable": "p", "patches": ["outlet"], "value": [101325.0]},
+            "T0": {"variable": "T", "patches": ["inlet"], "value": [300.0]},
+        },
+        "designSurfaces": ["wallsbump"],
+        "normalizeStates": {"U": 50.0, "p": 101325.0, "T": 300.0, "nuTilda": 1e-3, "phi": 1.0},
+    },
+    "DAPimpleFoam": {
+        "case": "NACA0012Unsteady",
+        "setup": ["rm -rf processor*"],
+        "primalBC": {"U0": {"variable": "U", "patches": ["inout"], "value": [10.0, 0.0, 0.0]}},
+        "designSurfaces": ["wing"],
+        "normalizeStates": {"U": 10.0, "p": 50.0, "nuTilda": 1e-3, "phi": 1.0},
+    },
+}
+
+
+def getAeroOptions(solverName):
+    """
+    Return the minimal DAFoam options for a benchmark case: CD as the objective
+    function and no design variable, so we only time the primal and adjoint.
+    NOTE: we use fixedDirection because parallelToFlow needs the alpha design variable
+    """
+
+    setup = benchmarkCases[solverName]
+    aeroOptions = {
+        "solverName": solverName,
+        "designSurfaces": setup["designSurfaces"],
+        "primalMinResTol": 1e-12,
+        "primalBC": setup["primalBC"],
+        "objFunc": {
+            "CD": {
+                "part1": {
+                    "type": "force",
+                    "source": "patchToFace",
+                    "patches": setup["designSurfaces"],
+                    "directionMode": "fixedDirection",
+                    "direction": [1.0, 0.0, 0.0],
+                    "scale": 1.0,
+                    "addToAdjoint": True,
+                }
+            },
+        },
+        "adjStateOrdering": "cell",
+        "adjEqnOption": {"gmresRelTol": 1.0e-8, "pcFillLevel": 1, "jacMatReOrdering": "natural"},
+        "normalizeStates": setup["normalizeStates"],
+        "profiler": {"active": True, "fileName": "DAFoamProfile.json"},
+    }
+    if solverName == "DAPimpleFoam":
+        aeroOptions["unsteadyAdjoint"] = {"mode": "timeAccurate", "PCMatPrecomputeInterval": 5}
+    if solverName == "DARhoSimpleFoam":
+        aeroOptions["primalVarBounds"] = {
+            "UMax": 1000.0,
+            "UMin": -1000.0,
+            "pMax": 500000.0,
+            "pMin": 20000.0,
+            "eMax": 500000.0,
+            "eMin": 100000.0,
+            "rhoMax": 5.0,
+            "rhoMin": 0.2,
+        }
+
+    return aeroOptions
+
+
+def runCase(solverName):
+    """
+    Run the primal, coloring, and adjoint for a case in the current folder and
+    write the profiler statistics. This is called by mpirun, see runBenchmark
+    """
+
+    from mpi4py import MPI
+    from dafoam import PYDAFOAM
+
+    gcomm = MPI.COMM_WORLD
+
+    DASolver = PYDAFOAM(options=getAeroOptions(solverName), comm=gcomm)
+    DASolver.resetProfile()
+
+    evalFuncs = ["CD"]
+    funcs = {}
+    DASolver()
+    DASolver.runColoring()
+    if DASolver.getOption("unsteadyAdjoint")["mode"] == "timeAccurate":
+        DASolver.evalFunctionsUnsteady(funcs, evalFuncs=evalFuncs)
+        DASolver.solveAdjointUnsteady()
+    else:
+        DASolver.evalFunctions(funcs, evalFuncs=evalFuncs)
+        DASolver.solveAdjoint()
+
+    nCells = gcomm.allreduce(DASolver.solver.getNLocalCells(), op=MPI.SUM)
+    if gcomm.rank == 0:
+        with open("nCells.txt", "w") as f:
+            f.write("%d\n" % nCells)
+
+    DASolver.writeProfile()
+
+
+def runBenchmark(solverName, refineLevel, nProcs):
+    """
+    Copy a test case to a work folder, refine its mesh refineLevel times, run it
+    with nProcs processors, and return the profiler summary
+    """
+
+    setup = benchmarkCases[solverName]
+    workDir = os.path.abspath("./benchmark/%s_L%d" % (solverName, refineLevel))
+    os.system("rm -rf %s && mkdir -p benchmark" % workDir)
+    os.system("cp -r ./input/%s %s" % (setup["case"], workDir))
+
+    for cmd in setup["setup"] + ["refineMesh -overwrite > /dev/null"] * refineLevel:
+        if subprocess.call(cmd, shell=True, cwd=workDir) != 0:
+            raise RuntimeError("%s failed for %s" % (cmd, workDir))
+
+    scriptName = os.path.abspath(__file__)
+    cmd = "mpirun --oversubscribe -np %d python %s --run %s > log.benchmark 2>&1" % (nProcs, scriptName, solverName)
+    if subprocess.call(cmd, shell=True, cwd=workDir) != 0:
+        raise RuntimeError("%s failed, see %s/log.benchmark" % (solverName, workDir))
+
+    with open(os.path.join(workDir, "nCells.txt"), "r") as f:
+        nCells = int(f.readline())
+    with open(os.path.join(workDir, "DAFoamProfile.json"), "r") as f:
+        profile = json.load(f)
+
+    return {"refineLevel": refineLevel, "nCells": nCells, "nProcs": nProcs, "summary": profile["summary"]}
+
+
+if __name__ == "__main__":
+
+    if len(sys.argv) == 3 and sys.argv[1] == "--run":
+        runCase(sys.argv[2])
+        sys.exit(0)
+
+    nProcs = 4
+    maxRefineLevel = 2
+    if len(sys.argv) > 1:
+        nProcs = int(sys.argv[1])
+    if len(sys.argv) > 2:
+        maxRefineLevel = int(sys.argv[2])
+
+    results = {}
+    for solverName in benchmarkCases.keys():
+        results[solverName] = []
+        for refineLevel in range(maxRefineLevel + 1):
+            print("Running benchmark %s with refine level %d...." % (solverName, refineLevel))
+            result = runBenchmark(solverName, refineLevel, nProcs)
+            results[solverName].append(result)
+            print("nCells: %d" % result["nCells"])
+            for phaseName, phase in result["summary"]["solver"]["phases"].items():
+                print("    %-60s %12.4f s" % (phaseName, phase["wallTimeMax"]))
+
+    with open("DAFoam_Benchmark.json", "w") as f:
+        json.dump(results, f, indent=4)
+
+    print("Benchmark results written to DAFoam_Benchmark.json")
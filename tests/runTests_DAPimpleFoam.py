@@ -11,6 +11,7 @@ from pygeo import *
 from pyspline import *
 from idwarp import *
 import numpy as np
+import copy
 from testFuncs import *
 
 calcFDSens = 0
@@ -264,6 +265,33 @@ else:
     funcsSens = {}
     funcsSens, fail = optFuncs.calcObjFuncSens(allDV, funcs)
 
+    # the totals computed with checkpointing, i.e., the states are recomputed from the
+    # checkpoints instead of being read from the disk, should match the ones above
+    funcsSensRef = copy.deepcopy(funcsSens)
+
+    def calcFuncsSens():
+        funcsCheck, fail = optFuncs.calcObjFuncValues(allDV)
+        funcsSensCheck, fail = optFuncs.calcObjFuncSens(allDV, funcsCheck)
+        return funcsSensCheck
+
+    checkpointOptions = {"checkpointMethod": "binomial", "nCheckpointsRAM": 3}
+    reg_compare_options(
+        DASolver, {"unsteadyAdjoint": checkpointOptions}, calcFuncsSens, funcsSensRef, 1e-6, 1e-10, "checkpointMethod=binomial"
+    )
+
+    # the totals computed with the states saved in the binary snapshot store (double precision
+    # is lossless, with and without compression) should match the OpenFOAM format ones
+    for compression in ["None", "shuffleRLE"]:
+        snapshotOptions = {"snapshotFormat": "binary", "snapshotPrecision": "double", "snapshotCompression": compression}
+        label = "snapshotCompression=%s" % compression
+        reg_compare_options(DASolver, {"unsteadyAdjoint": snapshotOptions}, calcFuncsSens, funcsSensRef, 1e-6, 1e-10, label)
+
+    # single precision snapshots round the states at which the adjoint is linearized to float32,
+    # so the totals only match up to that rounding error
+    snapshotOptions = {"snapshotFormat": "binary", "snapshotPrecision": "single"}
+    label = "snapshotPrecision=single"
+    reg_compare_options(DASolver, {"unsteadyAdjoint": snapshotOptions}, calcFuncsSens, funcsSensRef, 1e-3, 1e-6, label)
+
     parameterNormU = np.linalg.norm(funcsSens["CD"]["parameter"])
     funcsSens["CD"]["parameter"] = parameterNormU
 
@@ -221,6 +221,21 @@ else:
     xDV = DVGeo.getValues()
     funcs = {}
     funcs, fail = optFuncs.calcObjFuncValuesUnsteady(xDV)
+
+    # the fvSource field of the hyperbolic and gaussian actuator points and the objective
+    # functions computed with the cell bins should match the all-cell loop
+    fvSourceBins = DASolver.getOFField("fvSource", "vector", distributed=True)
+
+    def calcFuncsAllCells():
+        funcsAllCells, fail = optFuncs.calcObjFuncValuesUnsteady(xDV)
+        funcsAllCells["fvSource"] = DASolver.getOFField("fvSource", "vector", distributed=True)
+        return funcsAllCells
+
+    funcsAllCells = reg_compare_options(
+        DASolver, {"fvSourceCellBins": False}, calcFuncsAllCells, funcs, 1e-8, 1e-10, "fvSourceCellBins"
+    )
+    if not reg_compare_dict(funcsAllCells, {"fvSource": fvSourceBins}, 1e-12, 1e-12, "fvSourceCellBins"):
+        exit(1)
     funcsSens = {}
     funcsSens, fail = optFuncs.calcObjFuncSensUnsteady(xDV, funcs)
     if gcomm.rank == 0:
@@ -219,6 +219,10 @@ rVecNorm1 = rVec.norm(1)
 if rVecNorm != rVecNorm1:
     exit(1)
 
+# test the state transfer round trip with the index maps (non-contiguous for the cell
+# ordering), it aborts if the scalar list, residual array, and state vector transfers do not match
+DASolver.solver.benchmarkStateTransfer(1)
+
 # Test vector IO functions
 DASolver.solver.writeVectorASCII(rVec, b"rVecRead")
 DASolver.solver.writeVectorBinary(rVec, b"rVecRead")
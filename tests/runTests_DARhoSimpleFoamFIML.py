@@ -12,6 +12,7 @@ from pyspline import *
 from idwarp import *
 from pyoptsparse import Optimization, OPT
 import numpy as np
+import copy
 from testFuncs import *
 import petsc4py
 from petsc4py import PETSc
@@ -132,6 +133,21 @@ else:
     funcsSens = {}
     funcsSens, fail = optFuncs.calcObjFuncSens(iDV, funcs)
 
+    # the parameter derivatives from the hand-written neural network adjoint should match
+    # the central finite differences of the primal for the parameters with the largest derivatives
+    dFdPar = np.array(funcsSens["VAR"]["parameter"])
+    epsPar = 1e-3
+    for parI in np.argsort(-np.abs(dFdPar))[:2]:
+        funcsFD = []
+        for sign in [1.0, -1.0]:
+            iDVFD = copy.deepcopy(iDV)
+            iDVFD["parameter"][parI] += sign * epsPar
+            funcsP, fail = optFuncs.calcObjFuncValues(iDVFD)
+            funcsFD.append(funcsP["VAR"])
+        dFdParFD = {"VAR": (funcsFD[0] - funcsFD[1]) / (2.0 * epsPar)}
+        if not reg_compare_dict({"VAR": dFdPar[parI]}, dFdParFD, 1e-2, 1e-10, "parameter-%d" % parI):
+            exit(1)
+
     norm = np.linalg.norm(funcsSens["VAR"]["parameter"])
     funcsSens["VAR"]["parameter"] = norm
 
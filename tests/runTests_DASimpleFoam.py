@@ -7,6 +7,7 @@ from mpi4py import MPI
 from dafoam import PYDAFOAM, optFuncs
 import sys
 import os
+import glob
 from pygeo import *
 from pyspline import *
 from idwarp import *
@@ -257,6 +258,26 @@ else:
     allDV = {**xDV, **iDV}
     funcs = {}
     funcs, fail = optFuncs.calcObjFuncValues(allDV)
+
+    # the fvSource field of the smooth actuator disk and the objective functions (including
+    # THRUST, its volume sum) computed with the cell bins should match the all-cell loop
+    fvSourceBins = DASolver.getOFField("fvSource", "vector", distributed=True)
+
+    def calcFuncsAllCells():
+        funcsAllCells, fail = optFuncs.calcObjFuncValues(allDV)
+        funcsAllCells["fvSource"] = DASolver.getOFField("fvSource", "vector", distributed=True)
+        return funcsAllCells
+
+    funcsAllCells = reg_compare_options(
+        DASolver, {"fvSourceCellBins": False}, calcFuncsAllCells, funcs, 1e-8, 1e-10, "fvSourceCellBins"
+    )
+    if not reg_compare_dict(funcsAllCells, {"fvSource": fvSourceBins}, 1e-12, 1e-12, "fvSourceCellBins"):
+        exit(1)
+
+    # state transfer round trip with the index maps (contiguous for the state ordering), it
+    # aborts if the scalar list, residual array, and state vector transfers do not match
+    DASolver.solver.benchmarkStateTransfer(1)
+
     # test getForces
     forces = DASolver.getForces()
     fNorm = np.linalg.norm(forces.flatten())
@@ -265,6 +286,52 @@ else:
     
     funcsSens = {}
     funcsSens, fail = optFuncs.calcObjFuncSens(allDV, funcs)
+
+    # the totals computed with PETSc's greedy and jp distance-2 colorings should match the
+    # parallelD2 ones. We remove the dRdW coloring files so they are recomputed
+    def calcFuncsSensColoring():
+        if gcomm.rank == 0:
+            os.system("rm -f dRdWColoring_*")
+        gcomm.Barrier()
+        DASolver.runColoring()
+        funcsSensColoring, fail = optFuncs.calcObjFuncSens(allDV, funcs)
+        return funcsSensColoring
+
+    for coloringOptions in [
+        {"adjColoringMethod": "greedy", "adjColoringOrdering": "smallestLast"},
+        {"adjColoringMethod": "jp", "adjColoringOrdering": "largestFirst"},
+    ]:
+        label = "adjColoringMethod=%s" % coloringOptions["adjColoringMethod"]
+        reg_compare_options(DASolver, coloringOptions, calcFuncsSensColoring, funcsSens, 1e-4, 1e-6, label)
+
+    # the dRdW coloring files are keyed by the conMatHash of dRdWCon. A coloring computed for another
+    # mesh or decomposition (emulated by renaming the current files to another hash) must not be reused,
+    # and it must be kept for when we switch back to it. A coloring file without its .info is stale
+    coloringFiles = glob.glob("dRdWColoring_%d_fnv*.bin" % gcomm.size)
+    if len(coloringFiles) != 1:
+        print("Expect one dRdW coloring file but found: %s" % coloringFiles)
+        exit(1)
+    coloringName = coloringFiles[0][:-4]
+    otherName = "dRdWColoring_%d_fnv0000000000000000" % gcomm.size
+    for removeInfo in [False, True]:
+        if gcomm.rank == 0:
+            if removeInfo:
+                os.remove(coloringName + ".info")
+            else:
+                for ext in [".bin", ".info"]:
+                    os.rename(coloringName + ext, otherName + ext)
+        gcomm.Barrier()
+        DASolver.runColoring()
+        gcomm.Barrier()
+        for fileName in [coloringName + ".bin", coloringName + ".info", otherName + ".bin"]:
+            if not os.path.isfile(fileName):
+                print("%s not found after runColoring with removeInfo=%s!" % (fileName, removeInfo))
+                exit(1)
+        with open(coloringName + ".info", "r") as f:
+            if coloringName.split("_")[-1] not in f.read():
+                print("%s.info does not have the conMatHash of its file name!" % coloringName)
+                exit(1)
+
     if gcomm.rank == 0:
         reg_write_dict(funcs, 1e-8, 1e-10)
         reg_write_dict(funcsSens, 1e-4, 1e-6)
@@ -4,6 +4,7 @@ Run Python tests for DASimpleFoam
 """
 
 from mpi4py import MPI
+from petsc4py import PETSc
 from dafoam import PYDAFOAM, optFuncs
 import sys
 import os
@@ -12,6 +13,7 @@ from pyspline import *
 from idwarp import *
 from pyoptsparse import Optimization, OPT
 import numpy as np
+import copy
 from testFuncs import *
 
 calcFDSens = 0
@@ -198,8 +200,61 @@ else:
     funcs, fail = optFuncs.runPrimal()
     funcsSens = {}
     funcsSens, fail = optFuncs.runAdjoint(fileName="totalSens.txt")
+
+    # the totals computed by solving the adjoint for all objFuncs together should match the ones above
+    funcsSensRef = copy.deepcopy(funcsSens)
+    reg_compare_options(
+        DASolver, {"adjEqnOption": {"multiRHS": True}}, lambda: optFuncs.runAdjoint()[0], funcsSensRef, 1e-4, 1e-8, "multiRHS"
+    )
+
+    # the totals computed with the recycled adjoint solutions should also match. The first
+    # adjoint fills the recycle space (projection: the solutions, gcrodr: the deflation
+    # subspace) and the second one reuses it, so it should converge in fewer iterations
+    objFuncNames = [name for name in DASolver.getOption("objFunc") if name in DASolver.objFuncNames4Adj]
+
+    def runAdjointTwice():
+        funcsSensIters = {}
+        for i in range(2):
+            funcsSensIters["solve%d" % i] = optFuncs.runAdjoint()[0]
+            funcsSensIters["iters%d" % i] = {
+                name: DASolver.solverAD.getLinearEqnIters(name.encode()) for name in objFuncNames
+            }
+        return funcsSensIters
+
+    # gcrodr needs PETSc with HPDDM
+    recycleModes = ["projection"]
+    kspHPDDM = PETSc.KSP().create(PETSc.COMM_WORLD)
+    try:
+        kspHPDDM.setType("hpddm")
+        recycleModes.append("gcrodr")
+    except PETSc.Error:
+        print("PETSc is not built with HPDDM, skip the recycleMode=gcrodr test")
+    kspHPDDM.destroy()
+
+    for recycleMode in recycleModes:
+        label = "recycleMode=%s" % recycleMode
+        funcsSensIters = reg_compare_options(
+            DASolver,
+            {"adjEqnOption": {"recycleMode": recycleMode}},
+            runAdjointTwice,
+            {"solve0": funcsSensRef, "solve1": funcsSensRef},
+            1e-4,
+            1e-8,
+            label,
+        )
+        for name in objFuncNames:
+            if funcsSensIters["iters1"][name] >= funcsSensIters["iters0"][name]:
+                print("%s: the recycled solution of %s did not reduce the iterations!" % (label, name))
+                exit(1)
+        DASolver.destroyAdjointKSPs()
     optFuncs.calcFDSens(fileName="totalSensFD.txt")
 
+    # the dRdWTPC computed by batchedAD should match the FD one up to the FD truncation error
+    runTimes, relDiff = DASolver.benchmarkdRdWTPC()
+    if relDiff > 1e-3:
+        print("dRdWTPC relative difference between FD and batchedAD is too large: %g" % relDiff)
+        exit(1)
+
     # Force calculation routines
     # Compute force
     forces = DASolver.getForces()
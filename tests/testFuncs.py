@@ -5,6 +5,7 @@
 # sufficiently close to be considered equal.
 
 import numpy
+import copy
 import os
 import sys
 from mpi4py import MPI
@@ -52,6 +53,62 @@ def reg_write_dict(d, rel_tol=1e-12, abs_tol=1e-12):
             reg_write(d[key], rel_tol, abs_tol)
 
 
+def reg_compare_dict(d, dRef, rel_tol=1e-8, abs_tol=1e-10, label=""):
+    """
+    Compare all values in a dictionary with the ones in a reference dictionary computed in
+    the same run, e.g., the totals computed by an alternative method vs the default one,
+    whose values are checked against the refs. Return True if they match and print the
+    mismatched keys otherwise
+    """
+    match = True
+    for key in sorted(dRef.keys()):
+        if key not in d:
+            print("%s: key %s not found!" % (label, key))
+            match = False
+        elif type(dRef[key]) == dict:
+            if not reg_compare_dict(d[key], dRef[key], rel_tol, abs_tol, label + "-" + str(key)):
+                match = False
+        else:
+            val = numpy.atleast_1d(d[key]).flatten()
+            valRef = numpy.atleast_1d(dRef[key]).flatten()
+            if val.shape != valRef.shape:
+                print("%s: the size of key %s does not match!" % (label, key))
+                match = False
+                continue
+            absErr = numpy.abs(val - valRef)
+            relErr = absErr / (numpy.abs(valRef) + 1e-16)
+            if not numpy.all((absErr < abs_tol) | (relErr < rel_tol)):
+                print("%s: key %s does not match! %s vs ref %s" % (label, key, val, valRef))
+                match = False
+
+    return match
+
+
+def reg_compare_options(DASolver, options, evalFunc, dRef, rel_tol=1e-8, abs_tol=1e-10, label=""):
+    """
+    Set the DAFoam options, call evalFunc to recompute the values (e.g., the totals) with
+    them, and reset the options. The recomputed values are compared with dRef, computed
+    in the same run with the default options, using reg_compare_dict. Exit if they do not
+    match, otherwise return the recomputed values
+    """
+    optionsRef = {}
+    for key in options.keys():
+        optionsRef[key] = copy.deepcopy(DASolver.getOption(key))
+        DASolver.setOption(key, options[key])
+    DASolver.updateDAOption()
+
+    d = evalFunc()
+
+    for key in optionsRef.keys():
+        DASolver.setOption(key, optionsRef[key])
+    DASolver.updateDAOption()
+
+    if not reg_compare_dict(d, dRef, rel_tol, abs_tol, label):
+        exit(1)
+
+    return d
+
+
 def _reg_str_comp(str1, str2):
     """
     Compare the float values in str1 and str2 and determine if they